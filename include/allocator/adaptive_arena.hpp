@@ -0,0 +1,178 @@
+#pragma once
+
+#include <cstddef>  // std::byte, std::size_t
+#include <limits>   // std::numeric_limits
+#include <memory>   // std::unique_ptr
+#include <new>  // std::bad_array_new_length
+#include <string>   // std::string
+#include <vector>   // std::vector
+
+/// @brief The tuning knobs of an adaptive arena
+struct MyAdaptivePolicy
+{
+    /// @brief The smallest size the main buffer is allowed to shrink to
+    std::size_t minSz = 64;
+
+    /// @brief The largest size the main buffer is allowed to grow to (0 means unlimited)
+    std::size_t maxSz = 0;
+
+    /// @brief The main buffer grows by at least this factor when consecutive cycles spill
+    std::size_t growthFactor = 2;
+
+    /// @brief The number of consecutive under-used cycles before the main buffer shrinks
+    std::size_t shrinkAfter = 8;
+
+    /// @brief The extra room kept on top of the high-water mark when resizing (in percent)
+    /// @note A cycle counts as under-used when its high-water mark plus headroom is below the capacity
+    std::size_t headroomPercent = 25;
+};
+
+/// @brief A monotonic arena whose main buffer adapts to the high-water mark observed across clear() cycles
+///
+/// Requests that do not fit in the main buffer spill onto the heap and are released on clear().
+/// On clear() the arena looks at how many bytes the cycle needed in total:
+/// it grows right away to that high-water mark plus headroom if the cycle spilled,
+/// and only shrinks after several consecutive under-used cycles.
+/// Every pointer handed out by the arena is invalidated by clear(), just like MyBufferAllocator::clear().
+class MyAdaptiveArena
+{
+public:
+
+    /// @brief The largest size load() accepts from a file when maxSz is unset (1 GiB)
+    static constexpr std::size_t maxLoadedSz = std::size_t{1} << 30;
+
+    /// @brief Constructs an arena with an initial main buffer
+    /// @param name The name under which the learned size is persisted
+    /// @param initialSz The initial size of the main buffer
+    /// @param policy The growing and shrinking policy
+    /// @throw std::invalid_argument If the name is empty or spans several lines
+    explicit MyAdaptiveArena(std::string name, std::size_t initialSz = 0, MyAdaptivePolicy policy = {});
+
+    ~MyAdaptiveArena();
+
+    MyAdaptiveArena(const MyAdaptiveArena&) = delete;
+    MyAdaptiveArena& operator=(const MyAdaptiveArena&) = delete;
+
+    /// @brief Allocates bytes from the main buffer or spills onto the heap if the main buffer is exhausted
+    /// @param sz The number of bytes
+    /// @param alignment The alignment of the bytes
+    /// @return The pointer to the bytes
+    void* allocate(std::size_t sz, std::size_t alignment);
+
+    /// @brief Resets the arena and resizes the main buffer based on the high-water mark of this cycle
+    /// @note If the new main buffer cannot be allocated the old one is kept
+    void clear() noexcept;
+
+    /// @brief Reads the learned size of this arena from a file and resizes the main buffer accordingly
+    /// @note This invalidates every pointer handed out by the arena, so call it before the first allocation
+    /// @note The learned size is capped at maxSz, or at maxLoadedSz if maxSz is unset
+    /// @param path The path of the file
+    /// @return True if the file contains a valid entry for this arena and the main buffer is resized
+    bool load(const std::string& path);
+
+    /// @brief Writes the learned size of this arena into a file, keeping the other lines of the file
+    /// @note The file is written to "<path>.tmp" first and then renamed over the original file
+    /// @param path The path of the file
+    /// @return True if the file is written successfully
+    bool save(const std::string& path) const;
+
+    /// @brief Returns true if the pointer lies inside the main buffer
+    bool owns(const void* ptr) const noexcept;
+
+    const std::string& name() const noexcept { return name_; }
+    std::size_t capacity() const noexcept { return bufferSz_; }
+    std::size_t used() const noexcept { return curOffset_ + spilledSz_; }
+    std::size_t spilled() const noexcept { return spilledSz_; }
+    std::size_t lastPeak() const noexcept { return lastPeak_; }
+    std::size_t highWaterMark() const noexcept { return highWaterMark_; }
+
+private:
+    /// @brief Replaces the main buffer with a new one of the given size (clamped to the policy)
+    void resize(std::size_t sz);
+
+    /// @brief Frees all heap allocations made when the main buffer was exhausted
+    void releaseSpills() noexcept;
+
+    std::string name_;
+    MyAdaptivePolicy policy_;
+
+    std::unique_ptr<std::byte[]> buffer_;
+    std::size_t bufferSz_ = 0;
+    std::size_t curOffset_ = 0;
+
+    struct Spill
+    {
+        void* ptr;
+        std::size_t sz;
+        std::size_t alignment;
+    };
+
+    std::vector<Spill> spills_;
+    std::size_t spilledSz_ = 0;
+
+    std::size_t spillCycles_ = 0;
+    std::size_t lastPeak_ = 0;
+    std::size_t highWaterMark_ = 0;
+    std::size_t windowPeak_ = 0;
+    std::size_t underUsedCycles_ = 0;
+};
+
+/// @brief An STL allocator that draws its memory from a MyAdaptiveArena
+/// @tparam T The type of the elements
+template <typename T>
+class MyAdaptiveAllocator
+{
+public:
+
+    using value_type = T;
+    using size_type = std::size_t;
+
+    /// @brief Constructs an allocator that refers to an arena (the arena must outlive the allocator)
+    /// @param arena The arena
+    explicit MyAdaptiveAllocator(MyAdaptiveArena& arena) noexcept
+    : arena_(&arena)
+    {
+    }
+
+    template <typename U>
+    MyAdaptiveAllocator(const MyAdaptiveAllocator<U>& other) noexcept
+    : arena_(other.arena_)
+    {
+    }
+
+    /// @brief The allocate function
+    /// @param n The size of the new elements
+    /// @return The pointer of the allocator
+    /// @throw std::bad_array_new_length If the size of the elements overflows
+    T* allocate(std::size_t n)
+    {
+        if (n == 0) return nullptr;
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) throw std::bad_array_new_length();
+
+        return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    /// @brief The deallocate function (a no-op since the arena releases everything on clear())
+    void deallocate(T*, std::size_t) noexcept
+    {
+    }
+
+    /// @brief Returns true if both allocators refer to the same arena
+    template <typename U>
+    bool operator==(const MyAdaptiveAllocator<U>& other) const noexcept
+    {
+        return arena_ == other.arena_;
+    }
+
+    template <typename U>
+    bool operator!=(const MyAdaptiveAllocator<U>& other) const noexcept
+    {
+        return !(*this == other);
+    }
+
+private:
+    template <typename U>
+    friend class MyAdaptiveAllocator;
+
+    MyAdaptiveArena* arena_;
+};
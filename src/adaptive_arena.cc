@@ -0,0 +1,290 @@
+#include "allocator/adaptive_arena.hpp"
+
+#include <algorithm>    // std::all_of, std::find_if, std::max, std::min
+#include <cctype>   // std::isdigit
+#include <cstdio>   // std::remove, std::rename
+#include <exception>    // std::exception
+#include <fstream>  // std::ifstream, std::ofstream
+#include <limits>   // std::numeric_limits
+#include <memory>   // std::align
+#include <new>  // ::operator new, std::align_val_t, std::bad_alloc
+#include <optional> // std::optional
+#include <stdexcept>    // std::invalid_argument
+#include <utility>  // std::move, std::pair
+
+namespace
+{
+    constexpr std::size_t maxSize = std::numeric_limits<std::size_t>::max();
+
+    std::size_t saturatingAdd(std::size_t a, std::size_t b) noexcept
+    {
+        return (a > maxSize - b) ? maxSize : a + b;
+    }
+
+    std::size_t saturatingMul(std::size_t a, std::size_t b) noexcept
+    {
+        return (b != 0 && a > maxSize / b) ? maxSize : a * b;
+    }
+
+    /// @brief Returns the size plus the given percentage of headroom
+    std::size_t withHeadroom(std::size_t sz, std::size_t percent) noexcept
+    {
+        const std::size_t headroom = saturatingAdd(saturatingMul(sz / 100, percent), (sz % 100) * std::min<std::size_t>(percent, 100) / 100);
+        return saturatingAdd(sz, headroom);
+    }
+
+    /// @brief Parses a line of a size file, each line is "<name> <size>"
+    /// @return The name and the size, or nothing if the line is malformed
+    std::optional<std::pair<std::string, std::size_t>> parseEntry(const std::string& line)
+    {
+        // The name may contain spaces so we split at the last one
+        const auto pos = line.find_last_of(' ');
+        if (pos == std::string::npos || pos == 0) return std::nullopt;
+
+        // Only plain digits are accepted since std::stoull happily wraps a leading '-'
+        const std::string value = line.substr(pos + 1);
+        if (value.empty() || !std::all_of(value.begin(), value.end(), [](unsigned char c) { return std::isdigit(c); })) return std::nullopt;
+
+        try
+        {
+            return std::make_pair(line.substr(0, pos), static_cast<std::size_t>(std::stoull(value)));
+        }
+        catch (const std::exception&)
+        {
+            return std::nullopt;
+        }
+    }
+
+    /// @brief Reads all lines of a size file, including the ones that cannot be parsed
+    std::vector<std::string> readLines(const std::string& path)
+    {
+        std::vector<std::string> lines;
+
+        std::ifstream in(path);
+        std::string line;
+        while (std::getline(in, line))
+        {
+            lines.push_back(line);
+        }
+
+        return lines;
+    }
+}
+
+MyAdaptiveArena::MyAdaptiveArena(std::string name, std::size_t initialSz, MyAdaptivePolicy policy)
+: name_(std::move(name)),
+policy_(policy)
+{
+    // The name is written as the first field of a line in the size file
+    if (name_.empty() || name_.find('\n') != std::string::npos)
+    {
+        throw std::invalid_argument("arena name must be non-empty and single-line");
+    }
+
+    // Guard against a knob that would stall growing
+    policy_.growthFactor = std::max<std::size_t>(policy_.growthFactor, 2);
+
+    resize(initialSz);
+}
+
+MyAdaptiveArena::~MyAdaptiveArena()
+{
+    releaseSpills();
+}
+
+void* MyAdaptiveArena::allocate(std::size_t sz, std::size_t alignment)
+{
+    std::size_t space = bufferSz_ - curOffset_;
+    void* ptr = static_cast<void*>(buffer_.get() + curOffset_);
+    if (buffer_ && std::align(alignment, sz, ptr, space))
+    {
+        std::byte* aligned = static_cast<std::byte*>(ptr);
+        curOffset_ = (aligned - buffer_.get()) + sz;
+        return ptr;
+    }
+
+    // The main buffer is exhausted so we spill onto the heap
+    // and count the worst case padding so the next main buffer is large enough
+    void* spill = ::operator new(sz, std::align_val_t{alignment});
+    try
+    {
+        spills_.push_back({spill, sz, alignment});
+    }
+    catch (...)
+    {
+        ::operator delete(spill, sz, std::align_val_t{alignment});
+        throw;
+    }
+    spilledSz_ = saturatingAdd(spilledSz_, saturatingAdd(sz, alignment - 1));
+
+    return spill;
+}
+
+void MyAdaptiveArena::clear() noexcept
+{
+    const std::size_t peak = used();
+    lastPeak_ = peak;
+    highWaterMark_ = std::max(highWaterMark_, peak);
+
+    releaseSpills();
+    curOffset_ = 0;
+
+    const bool hasSpilled = spilledSz_ > 0;
+    spilledSz_ = 0;
+
+    // The new size is only decided here and applied at the end
+    // so the accounting of this cycle is already reset if the resize fails
+    std::size_t newSz = bufferSz_;
+
+    const std::size_t target = withHeadroom(peak, policy_.headroomPercent);
+    if (hasSpilled)
+    {
+        // Grow fast: the main buffer should hold the whole cycle plus headroom next time
+        // and if the previous cycle spilled as well we grow at least geometrically
+        newSz = target;
+        if (++spillCycles_ > 1)
+        {
+            newSz = std::max(newSz, saturatingMul(bufferSz_, policy_.growthFactor));
+        }
+        windowPeak_ = 0;
+        underUsedCycles_ = 0;
+    }
+    else if (target < bufferSz_)
+    {
+        // Shrink slowly: only after several consecutive under-used cycles
+        // and never below the largest peak (plus headroom) seen during those cycles
+        spillCycles_ = 0;
+        windowPeak_ = std::max(windowPeak_, peak);
+        if (++underUsedCycles_ >= policy_.shrinkAfter)
+        {
+            newSz = withHeadroom(windowPeak_, policy_.headroomPercent);
+            windowPeak_ = 0;
+            underUsedCycles_ = 0;
+        }
+    }
+    else
+    {
+        spillCycles_ = 0;
+        windowPeak_ = 0;
+        underUsedCycles_ = 0;
+    }
+
+    try
+    {
+        resize(newSz);
+    }
+    catch (const std::bad_alloc&)
+    {
+        // Keep the old main buffer, the next cycle simply spills again
+    }
+}
+
+bool MyAdaptiveArena::load(const std::string& path)
+{
+    for (const auto& line : readLines(path))
+    {
+        const auto entry = parseEntry(line);
+        if (entry && entry->first == name_)
+        {
+            releaseSpills();
+            spilledSz_ = 0;
+            spillCycles_ = 0;
+            windowPeak_ = 0;
+            underUsedCycles_ = 0;
+
+            // Never trust the file with an unbounded size
+            const std::size_t cap = (policy_.maxSz > 0) ? policy_.maxSz : maxLoadedSz;
+            try
+            {
+                resize(std::min(entry->second, cap));
+            }
+            catch (const std::bad_alloc&)
+            {
+                return false;
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool MyAdaptiveArena::save(const std::string& path) const
+{
+    // Lines we cannot parse belong to someone else so they are kept as they are
+    auto lines = readLines(path);
+    const std::string entry = name_ + ' ' + std::to_string(bufferSz_);
+
+    auto it = std::find_if(lines.begin(), lines.end(), [this](const std::string& line)
+    {
+        const auto parsed = parseEntry(line);
+        return parsed && parsed->first == name_;
+    });
+    if (it != lines.end())
+    {
+        *it = entry;
+    }
+    else
+    {
+        lines.push_back(entry);
+    }
+
+    // The file is shared by all arenas so we write a temporary file first and swap it in
+    // therefore a failed write never loses the sizes of other arenas
+    const std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::trunc);
+        for (const auto& line : lines)
+        {
+            out << line << '\n';
+        }
+        out.close();
+
+        if (!out)
+        {
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+    }
+
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0)
+    {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool MyAdaptiveArena::owns(const void* ptr) const noexcept
+{
+    const std::byte* p = static_cast<const std::byte*>(ptr);
+    return buffer_ && p >= buffer_.get() && p < buffer_.get() + bufferSz_;
+}
+
+void MyAdaptiveArena::resize(std::size_t sz)
+{
+    sz = std::max(sz, policy_.minSz);
+    if (policy_.maxSz > 0)
+    {
+        sz = std::min(sz, policy_.maxSz);
+    }
+
+    curOffset_ = 0;
+    if (sz != bufferSz_ || !buffer_)
+    {
+        // NOTE: no value-initialization since the arena never reads memory it has not handed out
+        // NOTE: the old buffer is kept if the allocation throws
+        buffer_.reset(sz > 0 ? new std::byte[sz] : nullptr);
+        bufferSz_ = sz;
+    }
+}
+
+void MyAdaptiveArena::releaseSpills() noexcept
+{
+    for (const auto& spill : spills_)
+    {
+        ::operator delete(spill.ptr, spill.sz, std::align_val_t{spill.alignment});
+    }
+    spills_.clear();
+}
@@ -2,11 +2,18 @@
 
 #include <catch2/catch.hpp>
 #include <array>    // std::array
+#include <cstdio>   // std::remove
+#include <filesystem>   // std::filesystem::exists, std::filesystem::temp_directory_path
+#include <fstream>  // std::ifstream, std::ofstream
+#include <limits>   // std::numeric_limits
+#include <new>  // std::bad_array_new_length
+#include <stdexcept>    // std::invalid_argument
 #include <memory_resource>  // std::pmr::monotonic_buffer_resource
 #include <span> // std::span
 #include <stdio.h> // printf
 
 #include "allocator/allocator.hpp"
+#include "allocator/adaptive_arena.hpp"
 
 TEST_CASE( "Elements Less Than Main Buffer", "[main]" )
 {
@@ -407,3 +414,282 @@ TEST_CASE( "Clear & Push Large Size Elements", "[main]" )
         REQUIRE_FALSE(isWithinBackup);
     }
 }
+
+TEST_CASE( "Adaptive Arena Grows After Spilling", "[adaptive]" )
+{
+    // The main buffer is too small for the first cycle so the elements spill onto the heap
+    // After clear the main buffer grows so that the same workload fits without spilling
+    constexpr std::size_t initialSz = 16;
+    constexpr std::size_t N = 100;
+
+    MyAdaptivePolicy policy;
+    policy.minSz = initialSz;
+    MyAdaptiveArena arena("grow", initialSz, policy);
+
+    for (std::size_t cycle {0}; cycle < 2; ++cycle)
+    {
+        std::vector<int, MyAdaptiveAllocator<int>> myVec{MyAdaptiveAllocator<int>(arena)};
+        myVec.reserve(N);
+        for (std::size_t i {0}; i < N; ++i)
+        {
+            myVec.emplace_back(static_cast<int>(i));
+        }
+
+        for (std::size_t i {0}; i < N; ++i)
+        {
+            REQUIRE(myVec.at(i) == static_cast<int>(i));
+        }
+
+        if (cycle == 0)
+        {
+            REQUIRE_FALSE(arena.owns(myVec.data()));
+            REQUIRE(arena.spilled() > 0);
+        }
+        else
+        {
+            REQUIRE(arena.owns(myVec.data()));
+            REQUIRE(arena.spilled() == 0);
+        }
+
+        arena.clear();
+    }
+
+    REQUIRE(arena.capacity() >= N * sizeof(int));
+    REQUIRE(arena.highWaterMark() >= N * sizeof(int));
+}
+
+TEST_CASE( "Adaptive Arena Shrinks Slowly", "[adaptive]" )
+{
+    // The main buffer is much larger than the workload
+    // It only shrinks after the configured number of consecutive under-used cycles and keeps some headroom
+    constexpr std::size_t initialSz = 4096;
+    constexpr std::size_t N = 10;
+
+    MyAdaptivePolicy policy;
+    policy.minSz = 8;
+    policy.shrinkAfter = 4;
+    policy.headroomPercent = 50;
+    MyAdaptiveArena arena("shrink", initialSz, policy);
+
+    auto runCycle = [&arena](std::size_t n)
+    {
+        std::vector<char, MyAdaptiveAllocator<char>> myVec{MyAdaptiveAllocator<char>(arena)};
+        myVec.reserve(n);
+        for (std::size_t i {0}; i < n; ++i)
+        {
+            myVec.emplace_back(static_cast<char>('a' + i % 26));
+        }
+        REQUIRE(arena.owns(myVec.data()));
+        myVec = {};
+        arena.clear();
+    };
+
+    // A well-used cycle in the middle of an under-used streak resets the streak
+    for (std::size_t cycle {0}; cycle + 1 < policy.shrinkAfter; ++cycle)
+    {
+        runCycle(N);
+    }
+    runCycle(initialSz);
+    REQUIRE(arena.capacity() == initialSz);
+
+    for (std::size_t cycle {0}; cycle < policy.shrinkAfter; ++cycle)
+    {
+        REQUIRE(arena.capacity() == initialSz);
+        runCycle(N);
+    }
+
+    REQUIRE(arena.capacity() == N + N / 2);
+    REQUIRE(arena.lastPeak() == N);
+
+    // The main buffer never shrinks below minSz
+    for (std::size_t cycle {0}; cycle < policy.shrinkAfter; ++cycle)
+    {
+        runCycle(1);
+    }
+    REQUIRE(arena.capacity() == policy.minSz);
+
+    // The main buffer never grows beyond maxSz
+    policy.maxSz = 64;
+    MyAdaptiveArena bounded("bounded", 16, policy);
+    for (std::size_t cycle {0}; cycle < 4; ++cycle)
+    {
+        bounded.allocate(1000, 1);
+        bounded.clear();
+        REQUIRE(bounded.capacity() <= policy.maxSz);
+    }
+    REQUIRE(bounded.capacity() == policy.maxSz);
+}
+
+TEST_CASE( "Adaptive Arena Converges After Overshoot", "[adaptive]" )
+{
+    // A workload that overflows slightly grows the main buffer to its peak plus headroom, not to twice the capacity
+    // After a one-off spike the main buffer shrinks back to the same spill-free size
+    constexpr std::size_t initialSz = 1000;
+    constexpr std::size_t peak = 1001;
+    constexpr std::size_t spike = 8000;
+    constexpr std::size_t steadySz = peak + peak / 4;
+
+    MyAdaptivePolicy policy;
+    policy.minSz = 16;
+    MyAdaptiveArena arena("converge", initialSz, policy);
+
+    for (std::size_t cycle {0}; cycle < 40; ++cycle)
+    {
+        arena.allocate(peak, 1);
+        arena.clear();
+    }
+    REQUIRE(arena.capacity() == steadySz);
+
+    arena.allocate(spike, 1);
+    arena.clear();
+    REQUIRE(arena.capacity() >= spike);
+
+    for (std::size_t cycle {0}; cycle < 4 * policy.shrinkAfter; ++cycle)
+    {
+        arena.allocate(peak, 1);
+        REQUIRE(arena.spilled() == 0);
+        arena.clear();
+    }
+    REQUIRE(arena.capacity() == steadySz);
+    REQUIRE(arena.highWaterMark() == spike);
+}
+
+TEST_CASE( "Adaptive Arena Persists Learned Sizes", "[adaptive]" )
+{
+    // Two named arenas write their learned sizes into the same file
+    // New arenas with the same names start with the learned sizes
+    const std::string path = (std::filesystem::temp_directory_path() / "myallocator_adaptive_arena_sizes.txt").string();
+    std::remove(path.c_str());
+
+    MyAdaptivePolicy policy;
+    policy.minSz = 16;
+    policy.maxSz = 4096;
+
+    {
+        MyAdaptiveArena first("first", 16, policy);
+        MyAdaptiveArena second("second", 128, policy);
+
+        first.allocate(100, alignof(std::max_align_t));
+        first.clear();
+        REQUIRE(first.capacity() > 16);
+
+        REQUIRE(first.save(path));
+        REQUIRE(second.save(path));
+        REQUIRE(first.save(path));
+
+        MyAdaptiveArena restoredFirst("first", 16, policy);
+        MyAdaptiveArena restoredSecond("second", 16, policy);
+        MyAdaptiveArena unknown("unknown", 16, policy);
+
+        REQUIRE(restoredFirst.load(path));
+        REQUIRE(restoredSecond.load(path));
+        REQUIRE_FALSE(unknown.load(path));
+
+        REQUIRE(restoredFirst.capacity() == first.capacity());
+        REQUIRE(restoredSecond.capacity() == second.capacity());
+        REQUIRE(unknown.capacity() == 16);
+    }
+
+    std::remove(path.c_str());
+
+    // A large learned size round-trips with the default policy
+    {
+        constexpr std::size_t learnedSz = 1 << 20;
+
+        MyAdaptiveArena learned("learned");
+        learned.allocate(learnedSz, 1);
+        learned.clear();
+        REQUIRE(learned.capacity() > learnedSz);
+        REQUIRE(learned.save(path));
+
+        MyAdaptiveArena restored("learned");
+        REQUIRE(restored.load(path));
+        REQUIRE(restored.capacity() == learned.capacity());
+
+        restored.allocate(learnedSz, 1);
+        REQUIRE(restored.spilled() == 0);
+    }
+
+    std::remove(path.c_str());
+
+    // Names that cannot be written as a single line are rejected
+    REQUIRE_THROWS_AS(MyAdaptiveArena("", 16, policy), std::invalid_argument);
+    REQUIRE_THROWS_AS(MyAdaptiveArena("two\nlines", 16, policy), std::invalid_argument);
+}
+
+TEST_CASE( "Adaptive Arena Rejects Malformed Sizes", "[adaptive]" )
+{
+    // Negative, non-numeric and out of range sizes are skipped
+    // Huge sizes are capped at maxSz, or at maxLoadedSz when maxSz is unset
+    // Saving keeps the lines that cannot be parsed
+    const std::string path = (std::filesystem::temp_directory_path() / "myallocator_adaptive_arena_malformed.txt").string();
+    {
+        std::ofstream out(path, std::ios::trunc);
+        out << "negative -1\n";
+        out << "letters 12abc\n";
+        out << "empty \n";
+        out << "overflow 999999999999999999999999\n";
+        out << "huge 99999999999999999\n";
+    }
+
+    MyAdaptivePolicy policy;
+    policy.minSz = 16;
+
+    MyAdaptiveArena negative("negative", 16, policy);
+    MyAdaptiveArena letters("letters", 16, policy);
+    MyAdaptiveArena empty("empty", 16, policy);
+    MyAdaptiveArena overflow("overflow", 16, policy);
+    MyAdaptiveArena huge("huge", 16, policy);
+    policy.maxSz = 4096;
+    MyAdaptiveArena bounded("huge", 16, policy);
+
+    REQUIRE_FALSE(negative.load(path));
+    REQUIRE_FALSE(letters.load(path));
+    REQUIRE_FALSE(empty.load(path));
+    REQUIRE_FALSE(overflow.load(path));
+    REQUIRE(huge.load(path));
+    REQUIRE(bounded.load(path));
+
+    REQUIRE(negative.capacity() == 16);
+    REQUIRE(letters.capacity() == 16);
+    REQUIRE(empty.capacity() == 16);
+    REQUIRE(overflow.capacity() == 16);
+    REQUIRE(huge.capacity() == MyAdaptiveArena::maxLoadedSz);
+    REQUIRE(bounded.capacity() == policy.maxSz);
+
+    REQUIRE(negative.save(path));
+    REQUIRE_FALSE(std::filesystem::exists(path + ".tmp"));
+
+    std::vector<std::string> lines;
+    {
+        std::ifstream in(path);
+        std::string line;
+        while (std::getline(in, line))
+        {
+            lines.push_back(line);
+        }
+    }
+
+    const std::vector<std::string> expected {
+        "negative -1",
+        "letters 12abc",
+        "empty ",
+        "overflow 999999999999999999999999",
+        "huge 99999999999999999",
+        "negative 16"
+    };
+    REQUIRE(lines == expected);
+
+    std::remove(path.c_str());
+}
+
+TEST_CASE( "Adaptive Allocator Rejects Overflowing Sizes", "[adaptive]" )
+{
+    // The number of bytes of a huge number of elements would wrap around
+    // Therefore the allocator throws instead of handing out a small block
+    MyAdaptiveArena arena("overflow");
+    MyAdaptiveAllocator<int> alloc(arena);
+
+    REQUIRE_THROWS_AS(alloc.allocate(std::numeric_limits<std::size_t>::max() / sizeof(int) + 1), std::bad_array_new_length);
+    REQUIRE(arena.used() == 0);
+}